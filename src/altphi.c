@@ -0,0 +1,252 @@
+/* altphi.c */
+/*
+ ** Lazy relevance vectors.
+ **  - ALTREP real vector backed by y and the compiled relevance function
+ **  - elements are evaluated on demand and cached per block
+ */
+
+#include "phi.h"
+#include "prof.h"
+#undef SEXP // allocS.h
+
+#include <R.h>
+#include <Rinternals.h>
+#include <R_ext/Altrep.h>
+
+#define PHI_BLOCK 4096 // number of elements evaluated (and cached) at once
+
+/*
+ data1: y (REALSXP)
+ data2: list(spline, blocks, full)
+   spline: packed hermiteSpl (see pchip_pack)
+   blocks: list of cached blocks, NULL until evaluated
+   full:   materialized vector, NULL until DATAPTR is requested
+ */
+#define ALTPHI_Y(x)      R_altrep_data1(x)
+#define ALTPHI_SPL(x)    VECTOR_ELT(R_altrep_data2(x), 0)
+#define ALTPHI_BLOCKS(x) VECTOR_ELT(R_altrep_data2(x), 1)
+#define ALTPHI_FULL(x)   VECTOR_ELT(R_altrep_data2(x), 2)
+
+static R_altrep_class_t altphi_class;
+
+/* ============================================================ */
+// evaluation of a contiguous region of y
+// (counted as elements of the r2phi_altrep call, not as calls)
+/* ============================================================ */
+static void altphi_fill(hermiteSpl *H, const double *y, R_xlen_t n,
+                        double *y_phi) {
+
+  R_xlen_t i;
+  PROF_START(t0);
+
+  for(i = 0; i < n; i++)
+    y_phi[i] = phiSpl_value(y[i], H).y_phi;
+
+  PROF_STOP_CALLS(PROF_PHI_ALTREP, 0, n, t0);
+
+}
+
+/* ============================================================ */
+// get (and evaluate, if needed) the cached block b
+/* ============================================================ */
+static double *altphi_block(SEXP x, R_xlen_t b) {
+
+  SEXP blocks = ALTPHI_BLOCKS(x), blk;
+  R_xlen_t n = XLENGTH(ALTPHI_Y(x)), from, len;
+  hermiteSpl H;
+
+  blk = VECTOR_ELT(blocks, b);
+
+  if(blk == R_NilValue) {
+
+    from = b * PHI_BLOCK;
+    len = (n - from < PHI_BLOCK) ? n - from : PHI_BLOCK;
+
+    blk = allocVector(REALSXP, len);
+    SET_VECTOR_ELT(blocks, b, blk);
+
+    pchip_view(REAL(ALTPHI_SPL(x)), &H);
+    altphi_fill(&H, REAL_RO(ALTPHI_Y(x)) + from, len, REAL(blk));
+  }
+
+  return REAL(blk);
+}
+
+/* ============================================================ */
+// ALTREP methods
+/* ============================================================ */
+static R_xlen_t altphi_Length(SEXP x) {
+
+  return XLENGTH(ALTPHI_Y(x));
+}
+
+static double altphi_Elt(SEXP x, R_xlen_t i) {
+
+  SEXP full = ALTPHI_FULL(x);
+
+  if(full != R_NilValue) return REAL(full)[i];
+
+  return altphi_block(x, i / PHI_BLOCK)[i % PHI_BLOCK];
+}
+
+static R_xlen_t altphi_Get_region(SEXP x, R_xlen_t i, R_xlen_t n,
+                                  double *buf) {
+
+  SEXP full = ALTPHI_FULL(x);
+  R_xlen_t len = XLENGTH(ALTPHI_Y(x)), k = 0, off, m;
+  double *blk;
+
+  if(i >= len) return 0;
+  if(n > len - i) n = len - i;
+
+  if(full != R_NilValue) {
+    memcpy(buf, REAL(full) + i, n*sizeof(double));
+    return n;
+  }
+
+  while(k < n) {
+    blk = altphi_block(x, (i + k) / PHI_BLOCK);
+    off = (i + k) % PHI_BLOCK;
+    m = PHI_BLOCK - off;
+    if(m > n - k) m = n - k;
+
+    memcpy(buf + k, blk + off, m*sizeof(double));
+    k += m;
+  }
+
+  return n;
+}
+
+static void *altphi_Dataptr(SEXP x, Rboolean writeable) {
+
+  SEXP full = ALTPHI_FULL(x), blocks, blk;
+  R_xlen_t n, b, nb;
+  hermiteSpl H;
+
+  if(full == R_NilValue) {
+
+    n = XLENGTH(ALTPHI_Y(x));
+    blocks = ALTPHI_BLOCKS(x);
+    nb = XLENGTH(blocks);
+
+    full = allocVector(REALSXP, n);
+    SET_VECTOR_ELT(R_altrep_data2(x), 2, full);
+
+    pchip_view(REAL(ALTPHI_SPL(x)), &H);
+
+    for(b = 0; b < nb; b++) {
+      blk = VECTOR_ELT(blocks, b);
+      if(blk != R_NilValue)
+        memcpy(REAL(full) + b * PHI_BLOCK, REAL(blk),
+               XLENGTH(blk)*sizeof(double));
+      else
+        altphi_fill(&H, REAL_RO(ALTPHI_Y(x)) + b * PHI_BLOCK,
+                    (n - b * PHI_BLOCK < PHI_BLOCK) ? n - b * PHI_BLOCK : PHI_BLOCK,
+                    REAL(full) + b * PHI_BLOCK);
+    }
+
+    // the blocks are no longer needed
+    SET_VECTOR_ELT(R_altrep_data2(x), 1, allocVector(VECSXP, 0));
+  }
+
+  return REAL(full);
+}
+
+static const void *altphi_Dataptr_or_null(SEXP x) {
+
+  SEXP full = ALTPHI_FULL(x);
+
+  return full == R_NilValue ? NULL : REAL(full);
+}
+
+// only evaluate the requested elements (e.g. head(), x[i])
+static SEXP altphi_Extract_subset(SEXP x, SEXP indx, SEXP call) {
+
+  SEXP ans;
+  R_xlen_t i, k, n = XLENGTH(ALTPHI_Y(x)), m;
+  double idx;
+
+  if(ALTPHI_FULL(x) != R_NilValue) return NULL;
+  if(TYPEOF(indx) != INTSXP && TYPEOF(indx) != REALSXP) return NULL;
+
+  m = XLENGTH(indx);
+
+  // leave NAs and out of bound indices to the default method
+  for(k = 0; k < m; k++) {
+    idx = TYPEOF(indx) == INTSXP ?
+      (INTEGER(indx)[k] == NA_INTEGER ? NA_REAL : INTEGER(indx)[k]) :
+      REAL(indx)[k];
+    if(ISNAN(idx) || idx < 1 || idx > n) return NULL;
+  }
+
+  PROTECT(ans = allocVector(REALSXP, m));
+
+  for(k = 0; k < m; k++) {
+    i = TYPEOF(indx) == INTSXP ?
+      (R_xlen_t) INTEGER(indx)[k] - 1 : (R_xlen_t) REAL(indx)[k] - 1;
+    REAL(ans)[k] = altphi_Elt(x, i);
+  }
+
+  UNPROTECT(1);
+  return ans;
+}
+
+/* ============================================================ */
+// r2phi_altrep
+// packed_spl is an already built spline (see pchip_pack), or NULL to
+// build it from phiF_args
+// To be called directly from R
+/* ============================================================ */
+SEXP r2phi_altrep(SEXP y, SEXP phiF_args, SEXP packed_spl) {
+
+  SEXP spl, state, ans;
+  hermiteSpl *H;
+  R_xlen_t n = XLENGTH(y);
+  PROF_START(t0);
+
+  PROTECT(state = allocVector(VECSXP, 3));
+
+  if(packed_spl != R_NilValue) {
+
+    // shared with R, so it must not change underneath us either
+    MARK_NOT_MUTABLE(packed_spl);
+    SET_VECTOR_ELT(state, 0, packed_spl);
+
+  } else {
+
+    H = phiSpl_init(REAL(phiF_args));
+
+    spl = allocVector(REALSXP, PCHIP_PACKED_SIZE(H->npts));
+    SET_VECTOR_ELT(state, 0, spl);
+    pchip_pack(H, REAL(spl));
+  }
+
+  SET_VECTOR_ELT(state, 1, allocVector(VECSXP, (n + PHI_BLOCK - 1) / PHI_BLOCK));
+
+  // y must not change underneath us
+  MARK_NOT_MUTABLE(y);
+
+  ans = R_new_altrep(altphi_class, y, state);
+
+  // the elements are added as they are evaluated (see altphi_fill)
+  PROF_STOP(PROF_PHI_ALTREP, 0, t0);
+
+  UNPROTECT(1);
+  return ans;
+}
+
+/* ============================================================ */
+// class registration (from R_init_IRon)
+/* ============================================================ */
+void altphi_init(DllInfo *dll) {
+
+  altphi_class = R_make_altreal_class("phi_altrep", "IRon", dll);
+
+  R_set_altrep_Length_method(altphi_class, altphi_Length);
+  R_set_altvec_Dataptr_method(altphi_class, altphi_Dataptr);
+  R_set_altvec_Dataptr_or_null_method(altphi_class, altphi_Dataptr_or_null);
+  R_set_altvec_Extract_subset_method(altphi_class, altphi_Extract_subset);
+  R_set_altreal_Elt_method(altphi_class, altphi_Elt);
+  R_set_altreal_Get_region_method(altphi_class, altphi_Get_region);
+
+}
@@ -0,0 +1,120 @@
+/* boot.c */
+/*
+ ** Bootstrap of SERA (and of SER at a given threshold).
+ **  - the threshold bin of each case is found once and reused by every
+ **    replicate
+ **  - replicates are drawn from counter-based streams keyed by
+ **    (seed, replicate), so the results do not depend on the number of
+ **    threads nor on the order in which replicates are run
+ **  - all models are evaluated on the same resamples (paired)
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "allocS.h" // ALLOC
+#include "sera.h"
+#include "rng.h"
+#include "prof.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/************************************************************/
+/*                                                          */
+/*        INTERFACE FUNCTIONS WITH R                        */
+/*                                                          */
+/************************************************************/
+
+/* ============================================================ */
+// sera_boot
+// ypred is a n x nm matrix (one column per model)
+// sera_rep (and ser_rep if do_ser) are B x nm matrices of replicates
+// To be called directly from R
+/* ============================================================ */
+void r2sera_boot(int *n, int *nm,
+                 double *y, double *ypred, double *y_phi,
+                 double *step, int *nth,
+                 double *t, int *do_ser,
+                 int *B, double *seed, int *nthreads,
+                 double *sera_rep, double *ser_rep) {
+
+  int i, m, M = *nm, T = *nth, nt = 1;
+  int *bin, *sel, *bin_na_all;
+  double *e, *bin_err_all, *curve_all, *ser_all;
+  PROF_START(t0);
+
+  // threshold bin of each case and its squared errors (row-wise)
+  if((bin = (int *) ALLOC(*n, sizeof(int))) == NULL) perror("boot.c: memory allocation error");
+  if((sel = (int *) ALLOC(*n, sizeof(int))) == NULL) perror("boot.c: memory allocation error");
+  if((e = (double *) ALLOC((long) *n * M, sizeof(double))) == NULL) perror("boot.c: memory allocation error");
+
+  for(i = 0; i < *n; i++) {
+    bin[i] = sera_bin(y_phi[i], *step, T);
+    sel[i] = !ISNAN(y_phi[i]) && y_phi[i] >= *t;
+    for(m = 0; m < M; m++)
+      e[(long) i * M + m] = (y[i] - ypred[i + (long) *n * m]) * (y[i] - ypred[i + (long) *n * m]);
+  }
+
+#ifdef _OPENMP
+  nt = *nthreads > 0 ? *nthreads : 1;
+#endif
+
+  // per thread work space
+  if((bin_err_all = (double *) ALLOC((long) nt * M * (T + 1), sizeof(double))) == NULL) perror("boot.c: memory allocation error");
+  if((bin_na_all = (int *) ALLOC((long) nt * M * (T + 1), sizeof(int))) == NULL) perror("boot.c: memory allocation error");
+  if((curve_all = (double *) ALLOC((long) nt * T, sizeof(double))) == NULL) perror("boot.c: memory allocation error");
+  if((ser_all = (double *) ALLOC((long) nt * M, sizeof(double))) == NULL) perror("boot.c: memory allocation error");
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nt) schedule(static)
+#endif
+  for(int b = 0; b < *B; b++) {
+
+    int tid = 0, j, k, r, mm;
+    uint64_t key = rng_key(*seed, (uint64_t) b);
+    double *bin_err, *curve, *ser, ev;
+    int *bin_na;
+
+#ifdef _OPENMP
+    tid = omp_get_thread_num();
+#endif
+
+    bin_err = bin_err_all + (long) tid * M * (T + 1);
+    bin_na = bin_na_all + (long) tid * M * (T + 1);
+    curve = curve_all + (long) tid * T;
+    ser = ser_all + (long) tid * M;
+
+    memset(bin_err, 0, (size_t) M * (T + 1) * sizeof(double));
+    memset(bin_na, 0, (size_t) M * (T + 1) * sizeof(int));
+    memset(ser, 0, (size_t) M * sizeof(double));
+
+    for(j = 0; j < *n; j++) {
+
+      r = rng_int(key, (uint64_t) j, *n);
+      k = bin[r];
+
+      for(mm = 0; mm < M; mm++) {
+        ev = e[(long) r * M + mm];
+
+        // as in sera_add, a NA relevance (k == T) is a NA error
+        if(k >= 0) {
+          if(k == T || ISNAN(ev)) bin_na[mm * (T + 1) + k]++;
+          else bin_err[mm * (T + 1) + k] += ev;
+        }
+
+        if(sel[r] && !ISNAN(ev)) ser[mm] += ev;
+      }
+    }
+
+    for(mm = 0; mm < M; mm++) {
+      sera_curve(T, bin_err + mm * (T + 1), bin_na + mm * (T + 1), curve);
+      sera_rep[b + (long) *B * mm] = sera_area(T, *step, curve);
+      if(*do_ser) ser_rep[b + (long) *B * mm] = ser[mm];
+    }
+  }
+
+  PROF_STOP(PROF_SERA_BOOT, (double) *n * *B, t0);
+
+}
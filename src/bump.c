@@ -23,6 +23,7 @@
 
 #include "allocS.h" // ALLOC
 #include "util.h"
+#include "prof.h"
 
 // MUST BE IMPROVED
 phi_bumps *bumps_set(hermiteSpl *H, double *loss_args) {
@@ -34,6 +35,7 @@ phi_bumps *bumps_set(hermiteSpl *H, double *loss_args) {
   int inBump = 1, j;
   int nB = H->npts, nb;
   int *critical_idx;
+  PROF_START(t0);
 
   if((critical_idx = (int *)ALLOC(nB,sizeof(int))) == NULL) perror("bump.c: memory allocation error");
   if((B = (phi_bumps *)ALLOC(1,sizeof(phi_bumps))) == NULL) perror("bump.c: memory allocation error");
@@ -149,5 +151,8 @@ phi_bumps *bumps_set(hermiteSpl *H, double *loss_args) {
 
   // cannot free this!
   //free(critical_idx);
+
+  PROF_STOP(PROF_BUMPS_SET, H->npts, t0);
+
   return B;
 }
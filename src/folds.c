@@ -0,0 +1,130 @@
+/* folds.c */
+/*
+ ** Relevance-stratified cross-validation.
+ **  - folds are dealt within each relevance bin from shuffled decks of
+ **    the k folds, so every bin is spread evenly over the folds
+ **  - the out-of-fold predictions of all folds are scored in one pass
+ */
+
+#include <math.h>
+
+#include "phi.h"
+#include "sera.h"
+#include "rng.h"
+#include "prof.h"
+
+/************************************************************/
+/*                                                          */
+/*        INTERFACE FUNCTIONS WITH R                        */
+/*                                                          */
+/************************************************************/
+
+/* ============================================================ */
+// phi_folds
+// fold (1, ..., k) of each case, stratified on nbins equal width
+// relevance bins (plus one bin for NA relevance)
+// To be called directly from R
+/* ============================================================ */
+void r2phi_folds(int *n, double *y,
+                 double *phiF_args,
+                 int *k, int *nbins, double *seed,
+                 int *fold) {
+
+  int i, j, b, t, nb = *nbins + 1;
+  int *deck, *dealt;
+  double y_phi;
+  hermiteSpl *H;
+  uint64_t *ctr;
+  PROF_START(t0);
+
+  if((deck = (int *) ALLOC((long) nb * *k, sizeof(int))) == NULL) perror("folds.c: memory allocation error");
+  if((dealt = (int *) ALLOC(nb, sizeof(int))) == NULL) perror("folds.c: memory allocation error");
+  if((ctr = (uint64_t *) ALLOC(nb, sizeof(uint64_t))) == NULL) perror("folds.c: memory allocation error");
+
+  // every deck starts empty (as if all of its folds were dealt)
+  for(b = 0; b < nb; b++) {
+    dealt[b] = *k;
+    for(j = 0; j < *k; j++) deck[b * *k + j] = j + 1;
+  }
+
+  // evaluated here (not through r2phi_eval), so that the relevance
+  // counts as part of this call only
+  H = phiSpl_init(phiF_args);
+
+  for(i = 0; i < *n; i++) {
+
+    y_phi = phiSpl_value(y[i], H).y_phi;
+
+    if(ISNAN(y_phi)) b = *nbins;
+    else {
+      b = (int) floor(y_phi * *nbins);
+      if(b < 0) b = 0;
+      if(b > *nbins - 1) b = *nbins - 1;
+    }
+
+    // reshuffle the deck of the bin (Fisher-Yates)
+    if(dealt[b] == *k) {
+      for(j = *k - 1; j > 0; j--) {
+        int r = rng_int(rng_key(*seed, (uint64_t) b), ctr[b]++, j + 1);
+        t = deck[b * *k + j]; deck[b * *k + j] = deck[b * *k + r]; deck[b * *k + r] = t;
+      }
+      dealt[b] = 0;
+    }
+
+    fold[i] = deck[b * *k + dealt[b]++];
+  }
+
+  PROF_STOP(PROF_PHI_FOLDS, *n, t0);
+
+}
+
+/* ============================================================ */
+// sera_folds
+// SER curves and SERA of the out-of-fold predictions of each fold
+// and of all folds pooled together (row k + 1)
+// errors is a (k + 1) x nth matrix (column-major, as in R)
+// To be called directly from R
+/* ============================================================ */
+void r2sera_folds(int *n, double *y, double *ypred, double *y_phi,
+                  int *fold, int *k,
+                  double *step, int *nth,
+                  double *errors, double *sera) {
+
+  int i, f, j, K = *k, T = *nth;
+  int *bin_na;
+  double *bin_err, *curve;
+  PROF_START(t0);
+
+  if((bin_err = (double *) ALLOC((long) (K + 1) * (T + 1), sizeof(double))) == NULL) perror("folds.c: memory allocation error");
+  if((bin_na = (int *) ALLOC((long) (K + 1) * (T + 1), sizeof(int))) == NULL) perror("folds.c: memory allocation error");
+  if((curve = (double *) ALLOC(T, sizeof(double))) == NULL) perror("folds.c: memory allocation error");
+
+  for(i = 0; i < *n; i++) {
+    f = fold[i];
+    if(f == NA_INTEGER || f < 1 || f > K) continue;
+    f--;
+
+    sera_add(y[i], ypred[i], y_phi[i], *step, T,
+             bin_err + (long) f * (T + 1), bin_na + (long) f * (T + 1));
+  }
+
+  // pooled bins
+  for(f = 0; f < K; f++)
+    for(j = 0; j <= T; j++) {
+      bin_err[(long) K * (T + 1) + j] += bin_err[(long) f * (T + 1) + j];
+      bin_na[(long) K * (T + 1) + j] += bin_na[(long) f * (T + 1) + j];
+    }
+
+  for(f = 0; f <= K; f++) {
+
+    sera_curve(T, bin_err + (long) f * (T + 1), bin_na + (long) f * (T + 1), curve);
+
+    sera[f] = sera_area(T, *step, curve);
+
+    for(j = 0; j < T; j++)
+      errors[f + (long) (K + 1) * j] = curve[j];
+  }
+
+  PROF_STOP(PROF_SERA_FOLDS, *n, t0);
+
+}
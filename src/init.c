@@ -10,14 +10,88 @@
 //extern void r2phi(void *, void *, void *, void *, void *, void *);
 // extern void r2phi(void *, void *, void *, void *, void *);
 extern void r2phi(SEXP *, double *, double *,double *);
+extern void r2phi_deriv(SEXP *, double *, double *, double *, double *);
+extern void r2phi_pack(double *, double *);
+extern void r2phi_multi(int *, double *, int *, double *, int *, int *, int *,
+                        double *, double *, int *, double *, double *);
+extern void r2phi_spl(SEXP *, double *, double *, double *);
+extern void r2phi_state_save(char **, double *, double *, double *, int *, int *);
+extern void r2phi_state_load(char **, int *, double *, int *);
+extern void r2phi_mmap(char **, char **, double *, double *, int *);
+extern void r2sera_mmap(char **, char **, char **, double *, double *, int *,
+                        double *, double *, double *, int *);
+extern void r2sera_bins(int *, double *, double *, double *, int *, double *,
+                        int *, int *, double *, double *, double *, double *);
+extern void r2sera_group(int *, double *, double *, double *, int *, int *,
+                         double *, int *, double *, double *);
+extern void r2phi_folds(int *, double *, double *, int *, int *, double *, int *);
+extern void r2sera_folds(int *, double *, double *, double *, int *, int *,
+                         double *, int *, double *, double *);
+extern void r2phi_grid(double *, double *, double *, int *, int *,
+                       double *, double *, int *);
+extern void r2box_stats(int *, double *, double *, double *, double *, double *,
+                        int *, double *, double *, double *, double *, int *, double *);
+extern void r2sera_boot(int *, int *, double *, double *, double *, double *, int *,
+                        double *, int *, int *, double *, int *, double *, double *);
+extern void r2util_grid(double *, double *, double *, int *, double *, int *, double *,
+                        int *, double *, double *);
+extern void r2util_grid_spl(double *, int *, double *, double *, int *, double *, int *, double *,
+                            int *, double *, double *);
+extern void r2util_interp(int *, double *, int *, double *, double *, double *,
+                          int *, double *, double *, double *, double *);
+extern void r2prof_control(int *);
+extern void r2prof_stats(int *, double *, double *, double *);
+extern void r2prof_now(double *);
+extern void r2prof_add(int *, double *, double *);
 
 static const R_CMethodDef CEntries[] = {
     {"r2phi", (DL_FUNC) &r2phi, 4},
+    {"r2phi_deriv", (DL_FUNC) &r2phi_deriv, 5},
+    {"r2phi_pack", (DL_FUNC) &r2phi_pack, 2},
+    {"r2phi_multi", (DL_FUNC) &r2phi_multi, 12},
+    {"r2phi_spl", (DL_FUNC) &r2phi_spl, 4},
+    {"r2phi_state_save", (DL_FUNC) &r2phi_state_save, 6},
+    {"r2phi_state_load", (DL_FUNC) &r2phi_state_load, 4},
+    {"r2phi_mmap", (DL_FUNC) &r2phi_mmap, 5},
+    {"r2sera_mmap", (DL_FUNC) &r2sera_mmap, 10},
+    {"r2sera_group", (DL_FUNC) &r2sera_group, 10},
+    {"r2sera_bins", (DL_FUNC) &r2sera_bins, 12},
+    {"r2sera_boot", (DL_FUNC) &r2sera_boot, 14},
+    {"r2phi_grid", (DL_FUNC) &r2phi_grid, 8},
+    {"r2box_stats", (DL_FUNC) &r2box_stats, 13},
+    {"r2phi_folds", (DL_FUNC) &r2phi_folds, 7},
+    {"r2sera_folds", (DL_FUNC) &r2sera_folds, 10},
+    {"r2util_grid", (DL_FUNC) &r2util_grid, 10},
+    {"r2util_grid_spl", (DL_FUNC) &r2util_grid_spl, 11},
+    {"r2util_interp", (DL_FUNC) &r2util_interp, 11},
+    {"r2prof_control", (DL_FUNC) &r2prof_control, 1},
+    {"r2prof_stats", (DL_FUNC) &r2prof_stats, 4},
+    {"r2prof_now", (DL_FUNC) &r2prof_now, 1},
+    {"r2prof_add", (DL_FUNC) &r2prof_add, 3},
     {NULL, NULL, 0}
 };
 
+/* .Call calls */
+extern SEXP r2phi_altrep(SEXP, SEXP, SEXP);
+extern SEXP r2obj_wse(SEXP, SEXP, SEXP);
+extern SEXP r2obj_sera(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP r2resample(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+
+static const R_CallMethodDef CallEntries[] = {
+    {"r2phi_altrep", (DL_FUNC) &r2phi_altrep, 3},
+    {"r2obj_wse", (DL_FUNC) &r2obj_wse, 3},
+    {"r2obj_sera", (DL_FUNC) &r2obj_sera, 5},
+    {"r2resample", (DL_FUNC) &r2resample, 6},
+    {NULL, NULL, 0}
+};
+
+/* ALTREP classes */
+extern void altphi_init(DllInfo *);
+
 void R_init_IRon(DllInfo *dll)
 {
-    R_registerRoutines(dll, CEntries, NULL, NULL, NULL);
+    R_registerRoutines(dll, CEntries, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
+
+    altphi_init(dll);
 }
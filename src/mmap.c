@@ -0,0 +1,424 @@
+/* mmap.c */
+/*
+ ** Relevance and SERA over raw little-endian double files that do not
+ ** fit in memory.
+ **  - the files are mapped in page aligned windows of MMAP_CHUNK bytes
+ **  - each window is advised as sequential and unmapped once consumed
+ ** Binary files of built relevance functions (spline, bumps and utility
+ ** parameters), so they can be mapped back without rebuilding them.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "util.h" // phi.h, bumps_set, util_init
+#include "sera.h"
+#include "prof.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define MMAP_CHUNK ((size_t) 1 << 26) // 64MB, a multiple of any page size
+
+// status codes returned to R
+#define MMAP_OK       0
+#define MMAP_EOPEN    1 // cannot open/stat a file
+#define MMAP_ESIZE    2 // not a whole number of doubles or sizes differ
+#define MMAP_EMAP     3 // mmap failed
+#define MMAP_EWRITE   4 // cannot create/extend the output file
+#define MMAP_ENOTSUP  5 // no mmap on this platform
+#define MMAP_EFORMAT  6 // not a relevance function file (or other version)
+#define MMAP_ECHECK   7 // checksum mismatch
+
+/*
+ relevance function file: a 24 bytes header followed by nd doubles
+  [0, 8)   magic "IRonPHI\0"
+  [8, 12)  version (uint32)
+  [12, 16) nd (uint32)
+  [16, 24) FNV-1a 64 checksum of the doubles (uint64)
+ all little-endian. The doubles are
+  method, npts, (x, y, m) x npts   as phiF_args
+  packed spline                    PCHIP_PACKED_SIZE(npts), see pchip_pack
+  nb, bleft[nb], bmax[nb], bloss[nb]
+  loss_args[3], utilF_args[3]
+ */
+#define PHI_STATE_MAGIC   "IRonPHI"
+#define PHI_STATE_VERSION 1
+#define PHI_STATE_HEADER  24
+#define PHI_STATE_SIZE(n, nb) (2 + 3 * (n) + PCHIP_PACKED_SIZE(n) + 1 + 3 * (nb) + 6)
+
+#ifndef _WIN32
+
+typedef struct {
+  int fd;
+  size_t size;
+  int prot;
+  double *win;
+  size_t win_len;
+} mmap_file;
+
+/* ============================================================ */
+// little-endian on disk
+/* ============================================================ */
+static double mmap_le(double v) {
+
+#ifdef WORDS_BIGENDIAN
+  unsigned char b[sizeof(double)], t;
+  int i;
+
+  memcpy(b, &v, sizeof(double));
+  for(i = 0; i < (int) sizeof(double) / 2; i++) {
+    t = b[i]; b[i] = b[sizeof(double) - 1 - i]; b[sizeof(double) - 1 - i] = t;
+  }
+  memcpy(&v, b, sizeof(double));
+#endif
+
+  return v;
+}
+
+static int mmap_open(mmap_file *f, const char *path) {
+
+  struct stat st;
+
+  f->win = NULL;
+  f->prot = PROT_READ;
+
+  if((f->fd = open(path, O_RDONLY)) < 0) return MMAP_EOPEN;
+  if(fstat(f->fd, &st) < 0) { close(f->fd); f->fd = -1; return MMAP_EOPEN; }
+
+  f->size = (size_t) st.st_size;
+  if(f->size % sizeof(double)) { close(f->fd); f->fd = -1; return MMAP_ESIZE; }
+
+  return MMAP_OK;
+}
+
+static int mmap_create(mmap_file *f, const char *path, size_t size) {
+
+  f->win = NULL;
+  f->prot = PROT_READ | PROT_WRITE;
+  f->size = size;
+
+  if((f->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) return MMAP_EWRITE;
+  if(ftruncate(f->fd, (off_t) size) < 0) { close(f->fd); f->fd = -1; return MMAP_EWRITE; }
+
+  return MMAP_OK;
+}
+
+/* ============================================================ */
+// map the window starting at off (a multiple of MMAP_CHUNK)
+/* ============================================================ */
+static int mmap_window(mmap_file *f, size_t off) {
+
+  void *p;
+
+  if(f->win != NULL) munmap(f->win, f->win_len);
+  f->win = NULL;
+
+  f->win_len = (f->size - off < MMAP_CHUNK) ? f->size - off : MMAP_CHUNK;
+  if(f->win_len == 0) return MMAP_OK;
+
+  p = mmap(NULL, f->win_len, f->prot, MAP_SHARED, f->fd, (off_t) off);
+  if(p == MAP_FAILED) return MMAP_EMAP;
+
+  madvise(p, f->win_len, MADV_SEQUENTIAL);
+  f->win = (double *) p;
+
+  return MMAP_OK;
+}
+
+static void mmap_close(mmap_file *f) {
+
+  if(f->fd < 0) return;
+  if(f->win != NULL) munmap(f->win, f->win_len);
+  f->win = NULL;
+  close(f->fd);
+  f->fd = -1;
+}
+
+#endif
+
+/* ============================================================ */
+// r2phi_mmap
+// y_file -> y_phi_file
+// To be called directly from R
+/* ============================================================ */
+void r2phi_mmap(char **y_file, char **y_phi_file,
+                double *phiF_args,
+                double *n, int *status) {
+
+#ifdef _WIN32
+  *status = MMAP_ENOTSUP;
+#else
+  mmap_file fy, fphi;
+  hermiteSpl *H;
+  size_t off, i, m;
+  PROF_START(t0);
+
+  fy.fd = fphi.fd = -1;
+  *n = 0;
+
+  if((*status = mmap_open(&fy, y_file[0])) != MMAP_OK) return;
+  if((*status = mmap_create(&fphi, y_phi_file[0], fy.size)) != MMAP_OK) {
+    mmap_close(&fy);
+    return;
+  }
+
+  H = phiSpl_init(phiF_args);
+
+  for(off = 0; off < fy.size; off += MMAP_CHUNK) {
+
+    if((*status = mmap_window(&fy, off)) != MMAP_OK ||
+       (*status = mmap_window(&fphi, off)) != MMAP_OK) break;
+
+    m = fy.win_len / sizeof(double);
+    for(i = 0; i < m; i++)
+      fphi.win[i] = mmap_le(phiSpl_value(mmap_le(fy.win[i]), H).y_phi);
+
+  }
+
+  if(*status == MMAP_OK) *n = (double) (fy.size / sizeof(double));
+
+  mmap_close(&fy);
+  mmap_close(&fphi);
+
+  PROF_STOP(PROF_PHI_MMAP, *n, t0);
+#endif
+}
+
+/* ============================================================ */
+// r2sera_mmap
+// (y_file, ypred_file [, y_phi_file]) -> SER curve and SERA
+// an empty y_phi_file means the relevance is computed on the fly
+// To be called directly from R
+/* ============================================================ */
+void r2sera_mmap(char **y_file, char **ypred_file, char **y_phi_file,
+                 double *phiF_args,
+                 double *step, int *nth,
+                 double *errors, double *sera,
+                 double *n, int *status) {
+
+#ifdef _WIN32
+  *status = MMAP_ENOTSUP;
+#else
+  mmap_file fy, fpred, fphi;
+  hermiteSpl *H = NULL;
+  int has_phi = y_phi_file[0][0] != '\0', *bin_na;
+  size_t off, i, m;
+  double *bin_err, yv, y_phi;
+  PROF_START(t0);
+
+  fy.fd = fpred.fd = fphi.fd = -1;
+  *n = 0;
+
+  if((bin_err = (double *) ALLOC(*nth + 1, sizeof(double))) == NULL) perror("mmap.c: memory allocation error");
+  if((bin_na = (int *) ALLOC(*nth + 1, sizeof(int))) == NULL) perror("mmap.c: memory allocation error");
+
+  if((*status = mmap_open(&fy, y_file[0])) != MMAP_OK) goto done;
+  if((*status = mmap_open(&fpred, ypred_file[0])) != MMAP_OK) goto done;
+  if(has_phi && (*status = mmap_open(&fphi, y_phi_file[0])) != MMAP_OK) goto done;
+
+  if(fpred.size != fy.size || (has_phi && fphi.size != fy.size)) {
+    *status = MMAP_ESIZE;
+    goto done;
+  }
+
+  if(!has_phi) H = phiSpl_init(phiF_args);
+
+  for(off = 0; off < fy.size; off += MMAP_CHUNK) {
+
+    if((*status = mmap_window(&fy, off)) != MMAP_OK ||
+       (*status = mmap_window(&fpred, off)) != MMAP_OK ||
+       (has_phi && (*status = mmap_window(&fphi, off)) != MMAP_OK)) goto done;
+
+    m = fy.win_len / sizeof(double);
+    for(i = 0; i < m; i++) {
+      yv = mmap_le(fy.win[i]);
+      y_phi = has_phi ? mmap_le(fphi.win[i]) : phiSpl_value(yv, H).y_phi;
+      sera_add(yv, mmap_le(fpred.win[i]), y_phi, *step, *nth, bin_err, bin_na);
+    }
+
+  }
+
+  sera_curve(*nth, bin_err, bin_na, errors);
+  *sera = sera_area(*nth, *step, errors);
+  *n = (double) (fy.size / sizeof(double));
+
+ done:
+  mmap_close(&fy);
+  mmap_close(&fpred);
+  mmap_close(&fphi);
+
+  PROF_STOP(PROF_SERA_MMAP, *n, t0);
+#endif
+}
+
+/************************************************************/
+/*                                                          */
+/*        RELEVANCE FUNCTION FILES                          */
+/*                                                          */
+/************************************************************/
+
+#ifndef _WIN32
+
+static void state_put_le(unsigned char *b, uint64_t v, int nbytes) {
+
+  int i;
+
+  for(i = 0; i < nbytes; i++) b[i] = (unsigned char) (v >> (8 * i));
+}
+
+static uint64_t state_get_le(const unsigned char *b, int nbytes) {
+
+  int i;
+  uint64_t v = 0;
+
+  for(i = 0; i < nbytes; i++) v |= (uint64_t) b[i] << (8 * i);
+
+  return v;
+}
+
+static uint64_t state_checksum(const unsigned char *b, size_t len) {
+
+  size_t i;
+  uint64_t h = 0xcbf29ce484222325ULL;
+
+  for(i = 0; i < len; i++) {
+    h ^= b[i];
+    h *= 0x100000001b3ULL;
+  }
+
+  return h;
+}
+
+#endif
+
+/* ============================================================ */
+// r2phi_state_save
+// builds the relevance function, its bumps and the utility
+// parameters and writes them to file
+// To be called directly from R
+/* ============================================================ */
+void r2phi_state_save(char **file,
+                      double *phiF_args, double *loss_args, double *utilF_args,
+                      int *nd, int *status) {
+
+#ifdef _WIN32
+  *status = MMAP_ENOTSUP;
+#else
+  mmap_file f;
+  phi_fun *phiF;
+  phi_bumps *bumpI;
+  util_fun *utilF;
+  double *st;
+  unsigned char *hdr;
+  int i, n, nb, k = 0;
+
+  f.fd = -1;
+
+  phiF = phi_init(phiF_args);
+  bumpI = bumps_set(phiF->H, loss_args);
+  utilF = util_init(utilF_args);
+
+  n = phiF->H->npts;
+  nb = bumpI->n;
+  *nd = PHI_STATE_SIZE(n, nb);
+
+  if((st = (double *) ALLOC(*nd, sizeof(double))) == NULL) perror("mmap.c: memory allocation error");
+
+  for(i = 0; i < 2 + 3 * n; i++) st[k++] = phiF_args[i];
+
+  pchip_pack(phiF->H, st + k);
+  k += PCHIP_PACKED_SIZE(n);
+
+  st[k++] = nb;
+  for(i = 0; i < nb; i++) st[k++] = bumpI->bleft[i];
+  for(i = 0; i < nb; i++) st[k++] = bumpI->bmax[i];
+  for(i = 0; i < nb; i++) st[k++] = bumpI->bloss[i];
+
+  for(i = 0; i < 3; i++) st[k++] = loss_args[i];
+  st[k++] = utilF->p;
+  st[k++] = utilF->Bmax;
+  st[k++] = utilF->event_thr;
+
+  if((*status = mmap_create(&f, file[0], PHI_STATE_HEADER + (size_t) *nd * sizeof(double))) != MMAP_OK) return;
+  if((*status = mmap_window(&f, 0)) != MMAP_OK) goto done;
+
+  hdr = (unsigned char *) f.win;
+
+  for(i = 0; i < *nd; i++)
+    f.win[PHI_STATE_HEADER / sizeof(double) + i] = mmap_le(st[i]);
+
+  memcpy(hdr, PHI_STATE_MAGIC, 8);
+  state_put_le(hdr + 8, PHI_STATE_VERSION, 4);
+  state_put_le(hdr + 12, (uint64_t) *nd, 4);
+  state_put_le(hdr + 16, state_checksum(hdr + PHI_STATE_HEADER, (size_t) *nd * sizeof(double)), 8);
+
+ done:
+  mmap_close(&f);
+#endif
+}
+
+/* ============================================================ */
+// r2phi_state_load
+// maps a file written by r2phi_state_save and copies its nd doubles
+// to state, after checking the header, the layout and the checksum
+// (nd is known in R from the size of the file)
+// To be called directly from R
+/* ============================================================ */
+void r2phi_state_load(char **file, int *nd, double *state, int *status) {
+
+#ifdef _WIN32
+  *status = MMAP_ENOTSUP;
+#else
+  mmap_file f;
+  const unsigned char *hdr;
+  int i, n, nb;
+
+  f.fd = -1;
+
+  if((*status = mmap_open(&f, file[0])) != MMAP_OK) return;
+
+  if(f.size < PHI_STATE_HEADER + 2 * sizeof(double) ||
+     f.size != PHI_STATE_HEADER + (size_t) *nd * sizeof(double) ||
+     f.size > MMAP_CHUNK) {
+    *status = MMAP_EFORMAT;
+    goto done;
+  }
+
+  if((*status = mmap_window(&f, 0)) != MMAP_OK) goto done;
+
+  hdr = (const unsigned char *) f.win;
+
+  if(memcmp(hdr, PHI_STATE_MAGIC, 8) != 0 ||
+     state_get_le(hdr + 8, 4) != PHI_STATE_VERSION ||
+     state_get_le(hdr + 12, 4) != (uint64_t) *nd) {
+    *status = MMAP_EFORMAT;
+    goto done;
+  }
+
+  if(state_get_le(hdr + 16, 8) != state_checksum(hdr + PHI_STATE_HEADER, (size_t) *nd * sizeof(double))) {
+    *status = MMAP_ECHECK;
+    goto done;
+  }
+
+  for(i = 0; i < *nd; i++)
+    state[i] = mmap_le(f.win[PHI_STATE_HEADER / sizeof(double) + i]);
+
+  // the layout must agree with the sizes it declares
+  n = (int) state[1];
+  nb = n >= 0 && 2 + 3 * n + PCHIP_PACKED_SIZE(n) < *nd ?
+    (int) state[2 + 3 * n + PCHIP_PACKED_SIZE(n)] : -1;
+
+  if(n < 0 || nb < 0 || *nd != PHI_STATE_SIZE(n, nb) ||
+     (int) state[2 + 3 * n] != n)
+    *status = MMAP_EFORMAT;
+
+ done:
+  mmap_close(&f);
+#endif
+}
@@ -0,0 +1,117 @@
+/* objective.c */
+/*
+ ** Gradient and hessian of relevance-weighted losses w.r.t. the
+ ** predictions, as expected by the custom objectives of boosting
+ ** libraries (one grad and one hess vector per round).
+ **  - the relevance of the trues and the packed spline are computed
+ **    once by the caller, each round only allocates the two outputs
+ */
+
+#include "phi.h"
+#include "prof.h"
+#undef SEXP // allocS.h
+
+#include <R.h>
+#include <Rinternals.h>
+
+#define OBJ_HESS_MIN 1e-6 // boosting libraries need a positive hessian
+
+static SEXP obj_alloc(R_xlen_t n, double **grad, double **hess) {
+
+  SEXP ans, nms;
+
+  PROTECT(ans = allocVector(VECSXP, 2));
+  SET_VECTOR_ELT(ans, 0, allocVector(REALSXP, n));
+  SET_VECTOR_ELT(ans, 1, allocVector(REALSXP, n));
+
+  PROTECT(nms = allocVector(STRSXP, 2));
+  SET_STRING_ELT(nms, 0, mkChar("grad"));
+  SET_STRING_ELT(nms, 1, mkChar("hess"));
+  setAttrib(ans, R_NamesSymbol, nms);
+
+  *grad = REAL(VECTOR_ELT(ans, 0));
+  *hess = REAL(VECTOR_ELT(ans, 1));
+
+  UNPROTECT(2);
+  return ans;
+}
+
+// the predictions must match the trues (e.g. not a multi-output model)
+// (error is undefined by allocS.h)
+static void obj_check(SEXP y, SEXP ypred, SEXP y_phi) {
+
+  if(XLENGTH(ypred) != XLENGTH(y) || XLENGTH(y_phi) != XLENGTH(y))
+    Rf_error("the predictions must have the same length as the trues (%lld, not %lld)",
+             (long long) XLENGTH(y), (long long) XLENGTH(ypred));
+}
+
+/* ============================================================ */
+// obj_wse
+// relevance-weighted squared error  sum phi(y) (ypred - y)^2
+// (SERA in the limit of an infinitely small step)
+// To be called directly from R
+/* ============================================================ */
+SEXP r2obj_wse(SEXP y, SEXP ypred, SEXP y_phi) {
+
+  SEXP ans;
+  R_xlen_t i, n = XLENGTH(y);
+  const double *yv = REAL_RO(y), *pv = REAL_RO(ypred), *phv = REAL_RO(y_phi);
+  double *grad, *hess;
+  PROF_START(t0);
+
+  obj_check(y, ypred, y_phi);
+
+  PROTECT(ans = obj_alloc(n, &grad, &hess));
+
+  for(i = 0; i < n; i++) {
+    grad[i] = 2 * phv[i] * (pv[i] - yv[i]);
+    hess[i] = 2 * phv[i] < OBJ_HESS_MIN ? OBJ_HESS_MIN : 2 * phv[i];
+  }
+
+  PROF_STOP(PROF_OBJECTIVE, n, t0);
+
+  UNPROTECT(1);
+  return ans;
+}
+
+/* ============================================================ */
+// obj_sera
+// smooth SERA surrogate  sum jphi(y, ypred) (ypred - y)^2
+// where jphi = p phi(y) + (1 - p) phi(ypred) is the joint relevance,
+// so that the relevance of the predictions is also accounted for
+// To be called directly from R
+/* ============================================================ */
+SEXP r2obj_sera(SEXP y, SEXP ypred, SEXP y_phi, SEXP spl, SEXP p) {
+
+  SEXP ans;
+  R_xlen_t i, n = XLENGTH(y);
+  const double *yv = REAL_RO(y), *pv = REAL_RO(ypred), *phv = REAL_RO(y_phi);
+  double *grad, *hess, pp = asReal(p);
+  double r, w, ph, dph, d2ph, h;
+  hermiteSpl H;
+  PROF_START(t0);
+
+  obj_check(y, ypred, y_phi);
+
+  pchip_view(REAL(spl), &H);
+
+  PROTECT(ans = obj_alloc(n, &grad, &hess));
+
+  for(i = 0; i < n; i++) {
+
+    pchip_val_deriv(&H, pv[i], 0, &ph, &dph, &d2ph);
+
+    r = pv[i] - yv[i];
+    w = jphi_value(phv[i], ph, pp);
+
+    grad[i] = (1 - pp) * dph * r * r + 2 * w * r;
+
+    h = (1 - pp) * (d2ph * r * r + 4 * dph * r) + 2 * w;
+    hess[i] = h < OBJ_HESS_MIN ? OBJ_HESS_MIN : h;
+  }
+
+  PROF_STOP(PROF_OBJECTIVE, n, t0);
+
+  UNPROTECT(1);
+  return ans;
+}
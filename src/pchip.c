@@ -21,6 +21,7 @@
 #include <R_ext/Applic.h> // to use findInterval
 
 #include "pchip.h"
+#include "prof.h"
 
 /*
  ** Memory defined with S_alloc is removed automatically
@@ -34,6 +35,7 @@ hermiteSpl *pchip_set(int n,
   int i;
   double *h, *delta, *new_m;
   hermiteSpl *H;
+  PROF_START(t0);
 
   if((H = (hermiteSpl *)ALLOC(1,sizeof(hermiteSpl))) == NULL) perror("pchip.c: memory allocation error");
 
@@ -71,6 +73,8 @@ hermiteSpl *pchip_set(int n,
       (h[i] *  h[i]);
   }
 
+  PROF_STOP(PROF_PCHIP_SET, n, t0);
+
   return H;
 }
 
@@ -168,3 +172,76 @@ void  pchip_val(hermiteSpl *H, double xval, int extrapol,
     s * H->d[i]));
 
 }
+
+//  Evaluate the cubic polynomial and its first two derivatives
+//  H'(s) = b + 2cs + 3ds^2, H''(s) = 2c + 6ds
+void  pchip_val_deriv(hermiteSpl *H, double xval, int extrapol,
+                      double *yval, double *dval, double *d2val) {
+
+  int i = 1, rightmost_closed = 0, all_inside = 0, mfl = 0;
+  double s;
+
+  i = findInterval(H->x,H->npts,
+                   xval,
+                   rightmost_closed,all_inside,i,&mfl);
+
+
+  // if extrapol is linear
+  if(extrapol == 0 && (i == 0 || i == H->npts)) {
+
+    if(i == H->npts) i--;
+
+    *yval = H->a[i] + H->b[i] * (xval - H->x[i]);
+    *dval = H->b[i];
+    *d2val = 0;
+
+    return;
+  }
+
+
+  i--;
+
+  s = (xval - H->x[i]);
+  *yval = H->a[i] + s * (H->b[i] +
+    s * (H->c[i] +
+    s * H->d[i]));
+  *dval = H->b[i] + s * (2 * H->c[i] +
+    s * 3 * H->d[i]);
+  *d2val = 2 * H->c[i] + s * 6 * H->d[i];
+
+}
+
+
+/*
+ Copy the spline coefficients into a flat buffer of
+ PCHIP_PACKED_SIZE(H->npts) doubles, so that the spline can outlive
+ the transient (S_alloc) memory it was built in.
+ */
+void pchip_pack(hermiteSpl *H, double *buf) {
+
+  int n = H->npts;
+
+  buf[0] = (double) n;
+  memcpy(buf + 1,         H->x, n*sizeof(double));
+  memcpy(buf + 1 +   n,   H->a, n*sizeof(double));
+  memcpy(buf + 1 + 2*n,   H->b, n*sizeof(double));
+  memcpy(buf + 1 + 3*n,   H->c, n*sizeof(double));
+  memcpy(buf + 1 + 4*n,   H->d, n*sizeof(double));
+
+}
+
+/*
+ Point a hermiteSpl at a packed buffer (no copies, no allocation).
+ */
+void pchip_view(double *buf, hermiteSpl *H) {
+
+  int n = (int) buf[0];
+
+  H->npts = n;
+  H->x = buf + 1;
+  H->a = buf + 1 +   n;
+  H->b = buf + 1 + 2*n;
+  H->c = buf + 1 + 3*n;
+  H->d = buf + 1 + 4*n;
+
+}
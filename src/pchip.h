@@ -45,3 +45,17 @@ double *pchip_slope_monoFC(int n, double *m, double *delta);
 void pchip_val(hermiteSpl *H,
                double xval, int extrapol,
                double *yval);
+
+void pchip_val_deriv(hermiteSpl *H,
+                     double xval, int extrapol,
+                     double *yval, double *dval, double *d2val);
+
+/*
+ packed layout of a hermiteSpl in a flat double buffer
+ [npts, x[npts], a[npts], b[npts], c[npts], d[npts]]
+ */
+#define PCHIP_PACKED_SIZE(n) (1 + 5 * (n))
+
+void pchip_pack(hermiteSpl *H, double *buf);
+
+void pchip_view(double *buf, hermiteSpl *H);
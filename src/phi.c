@@ -10,6 +10,7 @@
 #include <math.h>
 #include <string.h>
 #include "phi.h"
+#include "prof.h"
 
 /* ============================================================ */
 // new_phi
@@ -25,6 +26,63 @@ void r2phi(SEXP *n, double *y,
 
 }
 
+/* ============================================================ */
+// phi_deriv
+// relevance and its first derivative in one pass
+// To be called directly from R
+/* ============================================================ */
+void r2phi_deriv(SEXP *n, double *y,
+                 double *phiF_args,
+                 double *y_phi, double *y_dphi) {
+
+  int i;
+  double d2;
+  PROF_START(t0);
+
+  r2phi_init(phiF_args);
+
+  for(i = 0; i < (int) *n; i++)
+    pchip_val_deriv(phiF->H, y[i], 0, &y_phi[i], &y_dphi[i], &d2);
+
+  PROF_STOP(PROF_PHI_DERIV, *n, t0);
+
+}
+
+/* ============================================================ */
+// phi_pack
+// the built spline of phiF_args as a flat vector (see pchip_pack),
+// so that R can keep it and reuse it without rebuilding
+// To be called directly from R
+/* ============================================================ */
+void r2phi_pack(double *phiF_args, double *spl) {
+
+  pchip_pack(phiSpl_init(phiF_args), spl);
+
+}
+
+/* ============================================================ */
+// phi_spl
+// relevance from an already built (packed) spline, e.g. read back
+// from a relevance function file
+// To be called directly from R
+/* ============================================================ */
+void r2phi_spl(SEXP *n, double *y,
+               double *spl,
+               double *y_phi) {
+
+  int i;
+  hermiteSpl H;
+  PROF_START(t0);
+
+  pchip_view(spl, &H);
+
+  for(i = 0; i < (int) *n; i++)
+    y_phi[i] = phiSpl_value(y[i], &H).y_phi;
+
+  PROF_STOP(PROF_PHI_EVAL, *n, t0);
+
+}
+
 /**************************************************************/
 
 /* ============================================================ */
@@ -66,12 +124,15 @@ void r2phi_eval(SEXP *n, double *y,
 
   int i;
   phi_out y_phiF;
+  PROF_START(t0);
 
   for(i = 0; i < (int) *n; i++) {
     y_phiF = phiF->phiSpl_value(y[i], phiF->H);
     y_phi[i] = y_phiF.y_phi;
   }
 
+  PROF_STOP(PROF_PHI_EVAL, *n, t0);
+
 }
 
 
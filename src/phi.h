@@ -50,6 +50,16 @@ EXTERN void r2phi(SEXP *n, double *y,
                   double *phiF_args,
                   double *y_phi);
 
+EXTERN void r2phi_deriv(SEXP *n, double *y,
+                        double *phiF_args,
+                        double *y_phi, double *y_dphi);
+
+EXTERN void r2phi_pack(double *phiF_args, double *spl);
+
+EXTERN void r2phi_spl(SEXP *n, double *y,
+                      double *spl,
+                      double *y_phi);
+
 EXTERN void r2phi_init(double *phiF_args);
 
 EXTERN void r2phi_eval(SEXP *n, double *y,
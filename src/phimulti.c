@@ -0,0 +1,82 @@
+/* phimulti.c */
+/*
+ ** Many relevance functions over the same target variable.
+ **  - y is traversed once, in blocks that stay in cache while every
+ **    spline is applied to them
+ **  - optionally, the SERA of each function for a fixed prediction
+ */
+
+#include "phi.h"
+#include "sera.h"
+#include "prof.h"
+
+#define PHI_MULTI_BLOCK 2048 // values of y per block (16KB)
+
+/************************************************************/
+/*                                                          */
+/*        INTERFACE FUNCTIONS WITH R                        */
+/*                                                          */
+/************************************************************/
+
+/* ============================================================ */
+// phi_multi
+// phiF_args holds the arguments of the k relevance functions one
+// after the other, the j-th starting at args_off[j].
+// y_phi (if do_phi) gets the n x k relevance matrix (column-major)
+// sera (if do_sera) gets the SERA of ypred under each function
+// To be called directly from R
+/* ============================================================ */
+void r2phi_multi(int *n, double *y,
+                 int *k, double *phiF_args, int *args_off,
+                 int *do_phi, int *do_sera,
+                 double *ypred, double *step, int *nth,
+                 double *y_phi, double *sera) {
+
+  int i, j, off, len, T = *nth;
+  int *bin_na = NULL;
+  double *bin_err = NULL, *curve, *blk_phi;
+  hermiteSpl **H;
+  PROF_START(t0);
+
+  if((H = (hermiteSpl **) ALLOC(*k, sizeof(hermiteSpl *))) == NULL) perror("phimulti.c: memory allocation error");
+  if((blk_phi = (double *) ALLOC(PHI_MULTI_BLOCK, sizeof(double))) == NULL) perror("phimulti.c: memory allocation error");
+
+  if(*do_sera) {
+    if((bin_err = (double *) ALLOC((long) *k * (T + 1), sizeof(double))) == NULL) perror("phimulti.c: memory allocation error");
+    if((bin_na = (int *) ALLOC((long) *k * (T + 1), sizeof(int))) == NULL) perror("phimulti.c: memory allocation error");
+  }
+
+  for(j = 0; j < *k; j++)
+    H[j] = phiSpl_init(phiF_args + args_off[j]);
+
+  for(off = 0; off < *n; off += PHI_MULTI_BLOCK) {
+
+    len = (*n - off < PHI_MULTI_BLOCK) ? *n - off : PHI_MULTI_BLOCK;
+
+    for(j = 0; j < *k; j++) {
+
+      double *out = *do_phi ? y_phi + (long) j * *n + off : blk_phi;
+
+      for(i = 0; i < len; i++)
+        out[i] = phiSpl_value(y[off + i], H[j]).y_phi;
+
+      if(*do_sera)
+        for(i = 0; i < len; i++)
+          sera_add(y[off + i], ypred[off + i], out[i], *step, T,
+                   bin_err + (long) j * (T + 1), bin_na + (long) j * (T + 1));
+    }
+  }
+
+  if(*do_sera) {
+
+    if((curve = (double *) ALLOC(T, sizeof(double))) == NULL) perror("phimulti.c: memory allocation error");
+
+    for(j = 0; j < *k; j++) {
+      sera_curve(T, bin_err + (long) j * (T + 1), bin_na + (long) j * (T + 1), curve);
+      sera[j] = sera_area(T, *step, curve);
+    }
+  }
+
+  PROF_STOP(PROF_PHI_MULTI, (double) *n * *k, t0);
+
+}
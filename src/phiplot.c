@@ -0,0 +1,162 @@
+/* phiplot.c */
+/*
+ ** Native support for phiPlot on large data sets.
+ **  - the relevance curve on an adaptive grid over the data range,
+ **    refined around the knots of the spline
+ **  - the adjusted boxplot statistics and a sample of the outliers
+ */
+
+#include <math.h>
+
+#include "phi.h"
+#include "rng.h"
+#include "prof.h"
+
+#include <R_ext/Utils.h> // rPsort, R_rsort
+
+/************************************************************/
+/*                                                          */
+/*        INTERFACE FUNCTIONS WITH R                        */
+/*                                                          */
+/************************************************************/
+
+/* ============================================================ */
+// phi_grid
+// ngrid equally spaced points over [lo, hi], plus the knots in that
+// range and nref points on each side of them (within one grid step).
+// x and y_phi must hold ngrid + npts * (2 * nref + 1) values,
+// nout gets the number of (sorted, distinct) points
+// To be called directly from R
+/* ============================================================ */
+void r2phi_grid(double *phiF_args,
+                double *lo, double *hi, int *ngrid, int *nref,
+                double *x, double *y_phi, int *nout) {
+
+  int i, j, m = 0;
+  double h, xk;
+  hermiteSpl *H;
+  PROF_START(t0);
+
+  H = phiSpl_init(phiF_args);
+
+  h = *ngrid > 1 ? (*hi - *lo) / (*ngrid - 1) : 0;
+
+  for(i = 0; i < *ngrid; i++)
+    x[m++] = *lo + i * h;
+
+  for(i = 0; i < H->npts; i++)
+    for(j = -*nref; j <= *nref; j++) {
+      xk = H->x[i] + j * h / (*nref + 1);
+      if(xk >= *lo && xk <= *hi) x[m++] = xk;
+    }
+
+  R_rsort(x, m);
+
+  for(i = 0, j = 0; i < m; i++)
+    if(j == 0 || x[i] != x[j-1]) x[j++] = x[i];
+
+  *nout = j;
+
+  for(i = 0; i < j; i++)
+    y_phi[i] = phiSpl_value(x[i], H).y_phi;
+
+  PROF_STOP(PROF_PHI_GRID, j, t0);
+
+}
+
+/* ============================================================ */
+// box_stats
+// adjusted boxplot statistics (as in robustbase::adjboxStats) given
+// the medcouple tau of y:
+//  - the hinges by partial sorting (as in fivenum)
+//  - the fences, the whiskers and the number of outliers in one pass,
+//    keeping a uniform sample (reservoir) of at most nsample outliers
+// range gets the minimum and maximum of y
+// To be called directly from R
+/* ============================================================ */
+void r2box_stats(int *n, double *y,
+                 double *coef, double *a, double *b, double *tau,
+                 int *nsample, double *seed,
+                 double *stats, double *fence, double *range,
+                 int *nout, double *out) {
+
+  int i, m = 0, k, lo_k, hi_k, has_fence;
+  double *z, n4, d[5], iQ, wlo = INFINITY, whi = -INFINITY;
+  uint64_t key;
+  PROF_START(t0);
+
+  if((z = (double *) ALLOC(*n, sizeof(double))) == NULL) perror("phiplot.c: memory allocation error");
+
+  for(i = 0; i < *n; i++)
+    if(!ISNAN(y[i])) z[m++] = y[i];
+
+  *nout = 0;
+  if(m == 0) {
+    for(i = 0; i < 5; i++) stats[i] = NA_REAL;
+    fence[0] = fence[1] = range[0] = range[1] = NA_REAL;
+    goto done;
+  }
+
+  // fivenum positions (1-based)
+  n4 = floor((m + 3) / 2.0) / 2.0;
+  d[0] = 1; d[1] = n4; d[2] = (m + 1) / 2.0; d[3] = m + 1 - n4; d[4] = m;
+
+  for(i = 0; i < 5; i++) {
+    lo_k = (int) floor(d[i]) - 1;
+    hi_k = (int) ceil(d[i]) - 1;
+    rPsort(z, m, lo_k);
+    stats[i] = z[lo_k];
+    if(hi_k != lo_k) {
+      rPsort(z, m, hi_k);
+      stats[i] = 0.5 * (stats[i] + z[hi_k]);
+    }
+  }
+
+  range[0] = stats[0];
+  range[1] = stats[4];
+
+  iQ = stats[3] - stats[1];
+  has_fence = *coef > 0 && iQ > 0;
+
+  if(has_fence) {
+    if(*tau >= 0) {
+      fence[0] = stats[1] - *coef * iQ * exp(*a * *tau);
+      fence[1] = stats[3] + *coef * iQ * exp(*b * *tau);
+    } else {
+      fence[0] = stats[1] - *coef * iQ * exp(-*b * *tau);
+      fence[1] = stats[3] + *coef * iQ * exp(-*a * *tau);
+    }
+  } else {
+    fence[0] = fence[1] = NA_REAL;
+    goto done;
+  }
+
+  key = rng_key(*seed, 0);
+
+  for(i = 0; i < m; i++) {
+
+    if(z[i] < fence[0] || z[i] > fence[1]) {
+
+      // reservoir sampling (algorithm R)
+      if(*nout < *nsample) out[*nout] = z[i];
+      else {
+        k = rng_int(key, (uint64_t) *nout, *nout + 1);
+        if(k < *nsample) out[k] = z[i];
+      }
+      (*nout)++;
+
+    } else {
+      if(z[i] < wlo) wlo = z[i];
+      if(z[i] > whi) whi = z[i];
+    }
+  }
+
+  if(*nout > 0) {
+    stats[0] = wlo;
+    stats[4] = whi;
+  }
+
+ done:
+  PROF_STOP(PROF_BOX_STATS, *n, t0);
+
+}
@@ -0,0 +1,106 @@
+/* prof.c */
+/*
+ ** Hot path instrumentation counters and timers.
+ */
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "prof.h"
+
+int prof_on = 0;
+
+static double prof_calls[PROF_N];
+static double prof_elems[PROF_N];
+static double prof_ns[PROF_N];
+
+/* ============================================================ */
+// monotonic clock, in nanoseconds
+/* ============================================================ */
+uint64_t prof_now(void) {
+
+#ifdef _WIN32
+  LARGE_INTEGER c, f;
+
+  QueryPerformanceCounter(&c);
+  QueryPerformanceFrequency(&f);
+  return (uint64_t) ((double) c.QuadPart * 1e9 / (double) f.QuadPart);
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+void prof_add(prof_id id, double calls, double elems, uint64_t t0) {
+
+  prof_calls[id] += calls;
+  prof_elems[id] += elems;
+  prof_ns[id] += (double) (prof_now() - t0);
+
+}
+
+/************************************************************/
+/*                                                          */
+/*        INTERFACE FUNCTIONS WITH R                        */
+/*                                                          */
+/************************************************************/
+
+/* ============================================================ */
+// prof_control
+// switch the instrumentation on (1) or off (0), NA leaves it as is;
+// on gets the previous state
+// To be called directly from R
+/* ============================================================ */
+void r2prof_control(int *on) {
+
+  int prev = prof_on;
+
+  if(*on == 0 || *on == 1) prof_on = *on;
+  *on = prev;
+
+}
+
+/* ============================================================ */
+// prof_stats
+// copy (and optionally reset) the counters, PROF_N entries each
+// To be called directly from R
+/* ============================================================ */
+void r2prof_stats(int *reset,
+                  double *calls, double *elems, double *ns) {
+
+  memcpy(calls, prof_calls, PROF_N * sizeof(double));
+  memcpy(elems, prof_elems, PROF_N * sizeof(double));
+  memcpy(ns, prof_ns, PROF_N * sizeof(double));
+
+  if(*reset) {
+    memset(prof_calls, 0, PROF_N * sizeof(double));
+    memset(prof_elems, 0, PROF_N * sizeof(double));
+    memset(prof_ns, 0, PROF_N * sizeof(double));
+  }
+
+}
+
+/* ============================================================ */
+// prof_now / prof_add
+// timing of R level code
+// To be called directly from R
+/* ============================================================ */
+void r2prof_now(double *t) {
+
+  *t = (double) prof_now();
+
+}
+
+void r2prof_add(int *id, double *elems, double *t0) {
+
+  if(prof_on && *id >= 0 && *id < PROF_N)
+    prof_add((prof_id) *id, 1, *elems, (uint64_t) *t0);
+
+}
@@ -0,0 +1,68 @@
+/**
+
+ ** Hot path instrumentation.
+ **  Per entry point call counts, elements processed and cumulative
+ **  nanoseconds, only recorded when switched on (prof_on), so the
+ **  cost when off is a single test per call.
+
+ **/
+
+#include <stdint.h>
+
+#ifdef MAINHT
+#define EXTERN
+#else
+#define EXTERN extern
+#endif
+
+// keep up to date (in R and C), see profEntries in R/prof.R
+typedef enum {
+  PROF_PCHIP_SET,
+  PROF_BUMPS_SET,
+  PROF_PHI_EVAL,
+  PROF_UTIL_CORE,
+  PROF_PHI_ALTREP,
+  PROF_PHI_DERIV,
+  PROF_PHI_MMAP,
+  PROF_SERA_MMAP,
+  PROF_SERA_GROUP,
+  PROF_SERA_BOOT,
+  PROF_SERA_FOLDS,
+  PROF_PHI_FOLDS,
+  PROF_RESAMPLE,
+  PROF_OBJECTIVE,
+  PROF_PHI_GRID,
+  PROF_BOX_STATS,
+  PROF_PHI_MULTI,
+  PROF_SERA_BINS,
+  PROF_UTIL_GRID,
+  PROF_UTIL_INTERP,
+  PROF_SERA_R, // the R level loop of sera()
+  PROF_N
+} prof_id;
+
+EXTERN int prof_on;
+
+EXTERN uint64_t prof_now(void);
+
+EXTERN void prof_add(prof_id id, double calls, double elems, uint64_t t0);
+
+#define PROF_START(t0) uint64_t t0 = prof_on ? prof_now() : 0
+#define PROF_STOP(id, elems, t0) PROF_STOP_CALLS(id, 1, elems, t0)
+// time and elements of work done on behalf of an earlier call
+// (e.g. lazy evaluation), calls is then 0
+#define PROF_STOP_CALLS(id, calls, elems, t0) \
+  do { if(prof_on) prof_add(id, (double) (calls), (double) (elems), t0); } while(0)
+
+/* --------------------------------------------------------- */
+/* Interface with R */
+/* --------------------------------------------------------- */
+
+EXTERN void r2prof_control(int *on);
+
+EXTERN void r2prof_stats(int *reset,
+                         double *calls, double *elems, double *ns);
+
+EXTERN void r2prof_now(double *t);
+
+EXTERN void r2prof_add(int *id, double *elems, double *t0);
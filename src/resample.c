@@ -0,0 +1,158 @@
+/* resample.c */
+/*
+ ** Relevance-driven resampling of imbalanced regression data sets.
+ **  - cases with phi(y) >= thr are rare, the others are normal
+ **  - normal cases are undersampled uniformly without replacement
+ **    (selection sampling, in one streaming pass)
+ **  - rare cases are all kept, plus extra copies drawn with replacement
+ **    and probability proportional to their relevance (alias table)
+ **  - only row indices are returned, the data itself is never copied
+ */
+
+#include "phi.h"
+#include "rng.h"
+#include "prof.h"
+#undef SEXP // allocS.h
+
+#include <R.h>
+#include <Rinternals.h>
+
+// streams of a seed
+#define RESAMPLE_UNDER 0
+#define RESAMPLE_OVER  1
+
+/* ============================================================ */
+// Vose's alias table for the weights w[0..n-1]
+/* ============================================================ */
+static void alias_set(int n, double *w, double *prob, int *alias) {
+
+  int i, s, l, ns = 0, nl = 0;
+  int *small, *large;
+  double sum = 0;
+
+  small = (int *) R_alloc(n, sizeof(int));
+  large = (int *) R_alloc(n, sizeof(int));
+
+  for(i = 0; i < n; i++) sum += w[i];
+
+  for(i = 0; i < n; i++) {
+    prob[i] = sum > 0 ? w[i] * n / sum : 1;
+    alias[i] = i;
+    if(prob[i] < 1) small[ns++] = i;
+    else large[nl++] = i;
+  }
+
+  while(ns > 0 && nl > 0) {
+    s = small[--ns];
+    l = large[--nl];
+
+    alias[s] = l;
+    prob[l] = (prob[l] + prob[s]) - 1;
+
+    if(prob[l] < 1) small[ns++] = l;
+    else large[nl++] = l;
+  }
+
+  // numerical leftovers
+  while(nl > 0) prob[large[--nl]] = 1;
+  while(ns > 0) prob[small[--ns]] = 1;
+
+}
+
+static int alias_draw(int n, double *prob, int *alias,
+                      uint64_t key, uint64_t ctr) {
+
+  double u = rng_unif(key, ctr) * n;
+  int i = (int) u;
+
+  return (u - i) < prob[i] ? i : alias[i];
+}
+
+/************************************************************/
+/*                                                          */
+/*        INTERFACE FUNCTIONS WITH R                        */
+/*                                                          */
+/************************************************************/
+
+/* ============================================================ */
+// resample
+// 1-based row indices of the resampled data set: the kept normal
+// cases and the rare cases (both in their original order), followed
+// by the extra copies of the rare cases
+// To be called directly from R
+/* ============================================================ */
+SEXP r2resample(SEXP y, SEXP phiF_args, SEXP thr,
+                SEXP under, SEXP over, SEXP seed) {
+
+  SEXP ans;
+  int i, j, n = LENGTH(y), n_rare = 0, n_norm, k_norm, k_extra;
+  int *rare, *alias, *idx;
+  unsigned char *is_rare;
+  double *w, *prob, th = asReal(thr), sd = asReal(seed);
+  const double *yv = REAL_RO(y);
+  hermiteSpl *H;
+  uint64_t key;
+  PROF_START(t0);
+
+  H = phiSpl_init(REAL(phiF_args));
+
+  is_rare = (unsigned char *) R_alloc(n, sizeof(unsigned char));
+
+  // pass 1: relevance of each case (only a flag per case is kept)
+  for(i = 0; i < n; i++) {
+    is_rare[i] = phiSpl_value(yv[i], H).y_phi >= th;
+    n_rare += is_rare[i];
+  }
+
+  rare = (int *) R_alloc(n_rare, sizeof(int));
+  w = (double *) R_alloc(n_rare, sizeof(double));
+
+  for(i = 0, j = 0; i < n; i++)
+    if(is_rare[i]) {
+      rare[j] = i;
+      w[j++] = phiSpl_value(yv[i], H).y_phi;
+    }
+
+  n_norm = n - n_rare;
+  k_norm = (int) floor(asReal(under) * n_norm + 0.5);
+  if(k_norm > n_norm) k_norm = n_norm;
+  k_extra = n_rare > 0 ? (int) floor((asReal(over) - 1) * n_rare + 0.5) : 0;
+  if(k_extra < 0) k_extra = 0;
+
+  PROTECT(ans = allocVector(INTSXP, k_norm + n_rare + k_extra));
+  idx = INTEGER(ans);
+
+  // pass 2: selection sampling of the normal cases (Knuth's algorithm S)
+  key = rng_key(sd, RESAMPLE_UNDER);
+  for(i = 0, j = 0; i < n; i++) {
+
+    if(is_rare[i]) {
+      idx[j++] = i + 1;
+      continue;
+    }
+
+    if(k_norm > 0 && rng_unif(key, (uint64_t) i) * n_norm < k_norm) {
+      idx[j++] = i + 1;
+      k_norm--;
+    }
+    n_norm--;
+  }
+
+  // extra copies of the rare cases, weighted by relevance
+  if(k_extra > 0) {
+
+    prob = (double *) R_alloc(n_rare, sizeof(double));
+    alias = (int *) R_alloc(n_rare, sizeof(int));
+
+    alias_set(n_rare, w, prob, alias);
+
+    key = rng_key(sd, RESAMPLE_OVER);
+    for(i = 0; i < k_extra; i++)
+      idx[j++] = rare[alias_draw(n_rare, prob, alias, key, (uint64_t) i)] + 1;
+  }
+
+  PROF_STOP(PROF_RESAMPLE, n, t0);
+
+  UNPROTECT(1);
+  return ans;
+}
@@ -0,0 +1,28 @@
+/* rng.c */
+/*
+ ** Counter-based random numbers (splitmix64 finalizer).
+ */
+
+#include "rng.h"
+
+uint64_t rng_mix(uint64_t z) {
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t rng_key(double seed, uint64_t stream) {
+
+  return rng_mix(rng_mix((uint64_t) seed) + 0x9E3779B97F4A7C15ULL * (stream + 1));
+}
+
+double rng_unif(uint64_t key, uint64_t ctr) {
+
+  return (double) (rng_mix(key ^ rng_mix(ctr)) >> 11) * 0x1.0p-53;
+}
+
+int rng_int(uint64_t key, uint64_t ctr, int n) {
+
+  return (int) (rng_unif(key, ctr) * n);
+}
@@ -0,0 +1,27 @@
+/**
+
+ ** Counter-based random numbers.
+ **  A stream is identified by a key (derived from a seed and a stream
+ **  number) and its i-th draw only depends on (key, i), so parallel or
+ **  out of order consumers reproduce the same numbers for a given seed.
+
+ **/
+
+#include <stdint.h>
+
+#ifdef MAINHT
+#define EXTERN
+#else
+#define EXTERN extern
+#endif
+
+EXTERN uint64_t rng_mix(uint64_t z);
+
+// key of the stream-th stream of a seed
+EXTERN uint64_t rng_key(double seed, uint64_t stream);
+
+// ctr-th draw of the stream key, uniform in [0, 1)
+EXTERN double rng_unif(uint64_t key, uint64_t ctr);
+
+// ctr-th draw of the stream key, uniform in 0, ..., n - 1
+EXTERN int rng_int(uint64_t key, uint64_t ctr, int n);
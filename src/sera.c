@@ -0,0 +1,205 @@
+/* sera.c */
+/*
+ ** Squared error-relevance area kernels.
+ **  - one pass binning of the squared errors by relevance threshold
+ **  - SER curve by suffix sums, SERA by the trapezoidal rule
+ */
+
+#include <math.h>
+
+#include "allocS.h" // ALLOC
+#include "sera.h"
+#include "prof.h"
+
+/* ============================================================ */
+// sera_bin
+// same comparisons as phi >= k * step in R
+/* ============================================================ */
+int sera_bin(double phi, double step, int nth) {
+
+  int k;
+
+  if(ISNAN(phi)) return nth;
+  if(phi < 0) return -1;
+
+  k = (int) floor(phi / step);
+  if(k > nth - 1) k = nth - 1;
+
+  // guard against rounding in phi / step
+  while(k >= 0 && k * step > phi) k--;
+  while(k < nth - 1 && (k + 1) * step <= phi) k++;
+
+  return k;
+}
+
+/* ============================================================ */
+// sera_add
+// bin_err and bin_na have nth + 1 slots, the last one for NA relevance
+// (as in sera(), a NA relevance gives a NA row in every subset, so it
+// always counts as a NA error)
+/* ============================================================ */
+void sera_add(double y, double ypred, double y_phi,
+              double step, int nth,
+              double *bin_err, int *bin_na) {
+
+  int k;
+  double e;
+
+  k = sera_bin(y_phi, step, nth);
+  if(k < 0) return;
+
+  e = (y - ypred) * (y - ypred);
+
+  if(k == nth || ISNAN(e)) bin_na[k]++;
+  else bin_err[k] += e;
+
+}
+
+/* ============================================================ */
+// sera_curve
+// as in sera(), a threshold whose subset has any NA error gets 0
+/* ============================================================ */
+void sera_curve(int nth, double *bin_err, int *bin_na,
+                double *errors) {
+
+  int k, na = bin_na[nth];
+  double s = 0;
+
+  for(k = nth - 1; k >= 0; k--) {
+    s += bin_err[k];
+    na += bin_na[k];
+    errors[k] = na ? 0 : s;
+  }
+
+}
+
+/* ============================================================ */
+// sera_area
+/* ============================================================ */
+double sera_area(int nth, double step, double *errors) {
+
+  int k;
+  double area = 0;
+
+  for(k = 1; k < nth; k++)
+    area += step * (errors[k-1] + errors[k]) / 2;
+
+  return area;
+}
+
+
+/************************************************************/
+/*                                                          */
+/*        INTERFACE FUNCTIONS WITH R                        */
+/*                                                          */
+/************************************************************/
+
+/* ============================================================ */
+// sera_group
+// SER curves and SERA of every group in one pass over the data:
+// per group threshold bins, then per group suffix sums.
+// group holds 1-based codes (as.integer of a factor), NA are skipped.
+// as in sera(), a group with a NA relevance case gets a curve of 0
+// errors is a ngroups x nth matrix (column-major, as in R)
+// To be called directly from R
+/* ============================================================ */
+void r2sera_group(int *n, double *y, double *ypred, double *y_phi,
+                  int *group, int *ngroups,
+                  double *step, int *nth,
+                  double *errors, double *sera) {
+
+  int i, g, k, G = *ngroups, T = *nth;
+  int *bin_na;
+  double *bin_err, *curve;
+  PROF_START(t0);
+
+  if((bin_err = (double *) ALLOC((long) G * (T + 1), sizeof(double))) == NULL) perror("sera.c: memory allocation error");
+  if((bin_na = (int *) ALLOC((long) G * (T + 1), sizeof(int))) == NULL) perror("sera.c: memory allocation error");
+  if((curve = (double *) ALLOC(T, sizeof(double))) == NULL) perror("sera.c: memory allocation error");
+
+  for(i = 0; i < *n; i++) {
+    g = group[i];
+    if(g == NA_INTEGER || g < 1 || g > G) continue;
+    g--;
+
+    sera_add(y[i], ypred[i], y_phi[i], *step, T,
+             bin_err + (long) g * (T + 1), bin_na + (long) g * (T + 1));
+  }
+
+  for(g = 0; g < G; g++) {
+
+    sera_curve(T, bin_err + (long) g * (T + 1), bin_na + (long) g * (T + 1), curve);
+
+    sera[g] = sera_area(T, *step, curve);
+
+    for(k = 0; k < T; k++)
+      errors[g + (long) G * k] = curve[k];
+  }
+
+  PROF_STOP(PROF_SERA_GROUP, *n, t0);
+
+}
+
+/* ============================================================ */
+// sera_bins
+// error summary of each relevance bin in one pass over the data.
+// bin b (0-based) holds the cases with edges[b] <= phi < edges[b+1]
+// (phi >= edges[nedges-1] for the last one), slot nedges the cases
+// with NA relevance; cases with phi < edges[0] are not counted.
+// per slot: count (non-NA errors), na (NA errors), sum of absolute
+// errors, sum of squared errors, maximum absolute error and bias
+// (mean of ypred - y)
+// To be called directly from R
+/* ============================================================ */
+void r2sera_bins(int *n, double *y, double *ypred, double *y_phi,
+                 int *nedges, double *edges,
+                 int *count, int *na, double *sum_err, double *sum_sq,
+                 double *max_err, double *bias) {
+
+  int i, b, lo, hi, mid, B = *nedges;
+  double e;
+  PROF_START(t0);
+
+  for(b = 0; b <= B; b++) {
+    count[b] = na[b] = 0;
+    sum_err[b] = sum_sq[b] = bias[b] = 0;
+    max_err[b] = NA_REAL;
+  }
+
+  for(i = 0; i < *n; i++) {
+
+    if(ISNAN(y_phi[i])) b = B;
+    else if(B == 0 || y_phi[i] < edges[0]) continue;
+    else {
+      // last edge <= phi (same comparisons as phi >= edge in R)
+      lo = 0; hi = B - 1;
+      while(lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if(y_phi[i] >= edges[mid]) lo = mid;
+        else hi = mid - 1;
+      }
+      b = lo;
+    }
+
+    e = ypred[i] - y[i];
+
+    if(ISNAN(e)) {
+      na[b]++;
+      continue;
+    }
+
+    count[b]++;
+    bias[b] += e;
+    sum_sq[b] += e * e;
+
+    e = fabs(e);
+    sum_err[b] += e;
+    if(ISNAN(max_err[b]) || e > max_err[b]) max_err[b] = e;
+  }
+
+  for(b = 0; b <= B; b++)
+    bias[b] = count[b] ? bias[b] / count[b] : NA_REAL;
+
+  PROF_STOP(PROF_SERA_BINS, *n, t0);
+
+}
@@ -0,0 +1,50 @@
+/**
+
+ ** Squared error-relevance (SER) curve and area (SERA) kernels.
+ **
+ ** The thresholds are th_k = k * step, k = 0, ..., nth - 1 (as in
+ ** seq(0, 1, step)). A case with relevance phi contributes to every
+ ** threshold th_k <= phi, so accumulating its error on the highest such
+ ** bin and taking suffix sums gives the whole SER curve in one pass.
+
+ **/
+
+#ifndef FLOAT
+#define FLOAT double
+#endif
+
+#ifdef MAINHT
+#define EXTERN
+#else
+#define EXTERN extern
+#endif
+
+// highest threshold bin with th_k <= phi (-1 if none, nth if phi is NA)
+EXTERN int sera_bin(double phi, double step, int nth);
+
+// accumulate the squared error of one case on its threshold bin
+// (a NA relevance always counts as a NA error, as in sera())
+EXTERN void sera_add(double y, double ypred, double y_phi,
+                     double step, int nth,
+                     double *bin_err, int *bin_na);
+
+// suffix sums of the bins: SER(th_k) for all k (NA sums are set to 0)
+EXTERN void sera_curve(int nth, double *bin_err, int *bin_na,
+                       double *errors);
+
+// trapezoidal area under the SER curve
+EXTERN double sera_area(int nth, double step, double *errors);
+
+/* --------------------------------------------------------- */
+/* Interface with R */
+/* --------------------------------------------------------- */
+
+EXTERN void r2sera_group(int *n, double *y, double *ypred, double *y_phi,
+                         int *group, int *ngroups,
+                         double *step, int *nth,
+                         double *errors, double *sera);
+
+EXTERN void r2sera_bins(int *n, double *y, double *ypred, double *y_phi,
+                        int *nedges, double *edges,
+                        int *count, int *na, double *sum_err, double *sum_sq,
+                        double *max_err, double *bias);
@@ -10,6 +10,7 @@
 #include <math.h>
 
 #include "util.h"
+#include "prof.h"
 
 
 
@@ -96,6 +97,7 @@ void util_core(int n, double *y,  double *ypred,
                phi_out *y_phiF, phi_out *ypred_phiF,
                double *u) {
   int i;
+  PROF_START(t0);
 
   for(i = 0; i < n; i++) {
 
@@ -108,6 +110,8 @@ void util_core(int n, double *y,  double *ypred,
 
   }
 
+  PROF_STOP(PROF_UTIL_CORE, n, t0);
+
 }
 
 
@@ -49,6 +49,21 @@ EXTERN void r2util_eval(SEXP *n,
                         double *y,  double *ypred,
                         double *u);
 
+EXTERN void r2util_grid(double *phiF_args, double *loss_args, double *utilF_args,
+                        int *nx, double *gx, int *ny, double *gy,
+                        int *nthreads,
+                        double *u, double *cerr);
+
+EXTERN void r2util_grid_spl(double *spl, int *nb, double *bumps, double *utilF_args,
+                            int *nx, double *gx, int *ny, double *gy,
+                            int *nthreads,
+                            double *u, double *cerr);
+
+EXTERN void r2util_interp(int *nx, double *gx, int *ny, double *gy,
+                          double *u, double *cerr,
+                          int *n, double *y, double *ypred,
+                          double *uq, double *eq);
+
 EXTERN util_fun *util_init(double *utilF_args);
 
 EXTERN phi_bumps *bumps_set(hermiteSpl *H, double *loss_args);
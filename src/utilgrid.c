@@ -0,0 +1,222 @@
+/* utilgrid.c */
+/*
+ ** Utility surface over a (y, ypred) grid.
+ **  - the utility is tabulated once at the grid nodes (in parallel by
+ **    rows), with the relevance of every grid value computed only once
+ **  - the largest deviation of the bilinear interpolant from the
+ **    utility at the centre and at the edge mid points of each cell is
+ **    kept as the error estimate of that cell
+ **  - batch queries are answered by bilinear interpolation
+ */
+
+#include <math.h>
+
+#include <R_ext/Applic.h> // to use findInterval
+
+#include "util.h"
+#include "prof.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* ============================================================ */
+// utility at the grid nodes and error estimates of the cells
+/* ============================================================ */
+static void util_grid(phi_fun *phiF, phi_bumps *bumpI, util_fun *utilF,
+                      int NX, double *gx, int NY, double *gy,
+                      int nthreads,
+                      double *u, double *cerr) {
+
+  int j, nt = 1;
+  phi_out *gy_phi, *cy_phi;
+
+  // relevance of the ypred nodes and of the ypred cell centres
+  if((gy_phi = (phi_out *) ALLOC(NY, sizeof(phi_out))) == NULL) perror("utilgrid.c: memory allocation error");
+  if((cy_phi = (phi_out *) ALLOC(NY, sizeof(phi_out))) == NULL) perror("utilgrid.c: memory allocation error");
+
+  for(j = 0; j < NY; j++) {
+    gy_phi[j] = phiF->phiSpl_value(gy[j], phiF->H);
+    if(j < NY - 1)
+      cy_phi[j] = phiF->phiSpl_value((gy[j] + gy[j+1]) / 2, phiF->H);
+  }
+
+#ifdef _OPENMP
+  nt = nthreads > 0 ? nthreads : 1;
+#endif
+
+  // a row only depends on its y value, so rows are independent
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nt) schedule(static)
+#endif
+  for(int i = 0; i < NX; i++) {
+
+    int k;
+    phi_out x_phi;
+
+    x_phi = phiF->phiSpl_value(gx[i], phiF->H);
+
+    for(k = 0; k < NY; k++)
+      u[i + (long) NX * k] =
+        util_value(gx[i], gy[k], x_phi, gy_phi[k], phiF, bumpI, utilF);
+  }
+
+  // the corners of every cell are now known: the deviation of the
+  // bilinear interpolant is checked at the centre and at the mid
+  // points of the edges (the utility has kinks, so this is an
+  // estimate and not a strict bound)
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nt) schedule(static)
+#endif
+  for(int i = 0; i < NX - 1; i++) {
+
+    int k;
+    double xc, u00, u10, u01, u11, d, dmax;
+    phi_out x0_phi, x1_phi, c_phi;
+
+    xc = (gx[i] + gx[i+1]) / 2;
+    x0_phi = phiF->phiSpl_value(gx[i], phiF->H);
+    x1_phi = phiF->phiSpl_value(gx[i+1], phiF->H);
+    c_phi = phiF->phiSpl_value(xc, phiF->H);
+
+    for(k = 0; k < NY - 1; k++) {
+
+      u00 = u[i + (long) NX * k];
+      u10 = u[i + 1 + (long) NX * k];
+      u01 = u[i + (long) NX * (k + 1)];
+      u11 = u[i + 1 + (long) NX * (k + 1)];
+
+      // centre
+      dmax = fabs(util_value(xc, (gy[k] + gy[k+1]) / 2, c_phi, cy_phi[k],
+                             phiF, bumpI, utilF) - (u00 + u10 + u01 + u11) / 4);
+
+      // edges
+      d = fabs(util_value(xc, gy[k], c_phi, gy_phi[k], phiF, bumpI, utilF) - (u00 + u10) / 2);
+      if(d > dmax) dmax = d;
+      d = fabs(util_value(xc, gy[k+1], c_phi, gy_phi[k+1], phiF, bumpI, utilF) - (u01 + u11) / 2);
+      if(d > dmax) dmax = d;
+      d = fabs(util_value(gx[i], (gy[k] + gy[k+1]) / 2, x0_phi, cy_phi[k], phiF, bumpI, utilF) - (u00 + u01) / 2);
+      if(d > dmax) dmax = d;
+      d = fabs(util_value(gx[i+1], (gy[k] + gy[k+1]) / 2, x1_phi, cy_phi[k], phiF, bumpI, utilF) - (u10 + u11) / 2);
+      if(d > dmax) dmax = d;
+
+      cerr[i + (long) (NX - 1) * k] = dmax;
+    }
+  }
+
+}
+
+/************************************************************/
+/*                                                          */
+/*        INTERFACE FUNCTIONS WITH R                        */
+/*                                                          */
+/************************************************************/
+
+/* ============================================================ */
+// util_grid
+// gx (y values) and gy (ypred values) are increasing grids.
+// u gets the nx x ny utility matrix and cerr the (nx - 1) x (ny - 1)
+// error estimates of the cells (both column-major, as in R)
+// To be called directly from R
+/* ============================================================ */
+void r2util_grid(double *phiF_args, double *loss_args, double *utilF_args,
+                 int *nx, double *gx, int *ny, double *gy,
+                 int *nthreads,
+                 double *u, double *cerr) {
+
+  phi_fun *phiF;
+  phi_bumps *bumpI;
+  util_fun *utilF;
+  PROF_START(t0);
+
+  phiF = phi_init(phiF_args);
+  bumpI = bumps_set(phiF->H, loss_args);
+  utilF = util_init(utilF_args);
+
+  util_grid(phiF, bumpI, utilF, *nx, gx, *ny, gy, *nthreads, u, cerr);
+
+  PROF_STOP(PROF_UTIL_GRID, (double) *nx * *ny, t0);
+
+}
+
+/* ============================================================ */
+// util_grid_spl
+// as util_grid, from an already built relevance function (e.g. read
+// back with phi.load): the packed spline, the nb bumps given as
+// bleft[nb], bmax[nb], bloss[nb] and the utility parameters
+// To be called directly from R
+/* ============================================================ */
+void r2util_grid_spl(double *spl, int *nb, double *bumps, double *utilF_args,
+                     int *nx, double *gx, int *ny, double *gy,
+                     int *nthreads,
+                     double *u, double *cerr) {
+
+  hermiteSpl H;
+  phi_fun phiF;
+  phi_bumps bumpI;
+  PROF_START(t0);
+
+  pchip_view(spl, &H);
+
+  // (the method is not used by the utility)
+  phiF.H = &H;
+  phiF.phiSpl_value = phiSpl_value;
+
+  bumpI.n = *nb;
+  bumpI.bleft = bumps;
+  bumpI.bmax = bumps + *nb;
+  bumpI.bloss = bumps + 2 * *nb;
+
+  util_grid(&phiF, &bumpI, util_init(utilF_args), *nx, gx, *ny, gy, *nthreads, u, cerr);
+
+  PROF_STOP(PROF_UTIL_GRID, (double) *nx * *ny, t0);
+
+}
+
+/* ============================================================ */
+// util_interp
+// bilinear interpolation of the utility surface (see util_grid) at
+// the pairs (y, ypred), with the error estimate of their cell.
+// pairs outside the grid (or with NA) get NA
+// To be called directly from R
+/* ============================================================ */
+void r2util_interp(int *nx, double *gx, int *ny, double *gy,
+                   double *u, double *cerr,
+                   int *n, double *y, double *ypred,
+                   double *uq, double *eq) {
+
+  int q, i = 1, j = 1, mfl = 0, NX = *nx, NY = *ny;
+  double tx, ty;
+  PROF_START(t0);
+
+  for(q = 0; q < *n; q++) {
+
+    uq[q] = eq[q] = NA_REAL;
+
+    if(ISNAN(y[q]) || ISNAN(ypred[q]) || NX < 2 || NY < 2) continue;
+
+    // the previous cell is the starting guess (sorted queries are cheap)
+    i = findInterval(gx, NX, y[q], 1, 0, i, &mfl);
+    j = findInterval(gy, NY, ypred[q], 1, 0, j, &mfl);
+
+    if(i < 1 || i > NX - 1 || j < 1 || j > NY - 1) {
+      if(i < 1) i = 1;
+      if(j < 1) j = 1;
+      continue;
+    }
+
+    tx = (y[q] - gx[i-1]) / (gx[i] - gx[i-1]);
+    ty = (ypred[q] - gy[j-1]) / (gy[j] - gy[j-1]);
+
+    uq[q] =
+      (1 - tx) * (1 - ty) * u[i - 1 + (long) NX * (j - 1)] +
+      tx * (1 - ty) * u[i + (long) NX * (j - 1)] +
+      (1 - tx) * ty * u[i - 1 + (long) NX * j] +
+      tx * ty * u[i + (long) NX * j];
+
+    eq[q] = cerr[i - 1 + (long) (NX - 1) * (j - 1)];
+  }
+
+  PROF_STOP(PROF_UTIL_INTERP, *n, t0);
+
+}